@@ -0,0 +1,203 @@
+#ifndef CUTOPTIMIZER_H
+#define CUTOPTIMIZER_H
+
+#include <TAxis.h>
+#include <TH1.h>
+#include <THnBase.h>
+#include <TMath.h>
+#include <TString.h>
+
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "SampleList.h"
+#include "SampleLoader.h"
+#include "SummedAreaTable.h"
+
+// Upper bound on the dense copy of one distribution (under/overflow included)
+static const size_t kMaxGridCells = 10000000;
+// Upper bound on the number of cut sets scored by one optimizeCuts call
+static const size_t kMaxCandidates = 2000000000;
+
+// Dense copy of a TH1/TH2/TH3 or of a THnBase (THn, THnSparse), under- and
+// overflow bins included so that one-sided cuts run to -inf / +inf
+inline bool toDenseGrid(const TObject* obj, DenseGrid& grid, std::vector<const TAxis*>& axes) {
+  axes.clear();
+  if (auto h = dynamic_cast<const TH1*>(obj)) {
+    const TAxis* all[3] = {h->GetXaxis(), h->GetYaxis(), h->GetZaxis()};
+    for (int d = 0; d < h->GetDimension(); ++d) axes.push_back(all[d]);
+  }
+  else if (auto hn = dynamic_cast<const THnBase*>(obj)) {
+    for (int d = 0; d < hn->GetNdimensions(); ++d) axes.push_back(hn->GetAxis(d));
+  }
+  else return false;
+
+  std::vector<int> nBins;
+  size_t cells = 1;
+  for (auto ax : axes) {
+    nBins.push_back(ax->GetNbins() + 2);
+    cells *= nBins.back();
+  }
+  if (cells > kMaxGridCells) {
+    std::cerr << obj->GetName() << ": " << cells << " bins are too many for a dense table" << std::endl;
+    return false;
+  }
+  grid = DenseGrid(nBins);
+
+  if (auto h = dynamic_cast<const TH1*>(obj)) {
+    const int nx = nBins[0];
+    const int ny = nBins.size() > 1 ? nBins[1] : 1;
+    const int nz = nBins.size() > 2 ? nBins[2] : 1;
+    for (int ix = 0; ix < nx; ++ix)
+      for (int iy = 0; iy < ny; ++iy)
+        for (int iz = 0; iz < nz; ++iz)
+          grid.content[(size_t(ix)*ny + iy)*nz + iz] = h->GetBinContent(h->GetBin(ix, iy, iz));
+  }
+  else {
+    auto hn = static_cast<const THnBase*>(obj);
+    std::vector<int> coord(nBins.size());
+    for (Long64_t i = 0; i < hn->GetNbins(); ++i) {
+      const double c = hn->GetBinContent(i, coord.data());
+      if (c != 0.0) grid.content[grid.Index(coord)] += c;
+    }
+  }
+  return true;
+}
+
+inline std::function<double(double,double)> cutMetric(const TString& metric) {
+  if (metric == "signif")     return [](double S, double B) { return S/TMath::Sqrt(S+B); };
+  if (metric == "soversqrtb") return [](double S, double B) { return S/TMath::Sqrt(B); };
+  if (metric == "sob")        return [](double S, double B) { return S/B; };
+  if (metric == "asimov")     return [](double S, double B) { return TMath::Sqrt(2*((S+B)*TMath::Log(1+S/B) - S)); };
+  return nullptr;
+}
+
+// Finds the nTop rectangular cuts on histName (TH2, TH3 or THnSparse in
+// <sample>_hist.root) that maximise metric, with the first sample of
+// text_file as signal and all others summed as background.
+//   windows = true : every [lo, hi] window on every axis
+//   windows = false: one-sided cuts only, x <= X or x >= X (or no cut) per axis
+//   metric         : signif = S/Sqrt(S+B), soversqrtb = S/Sqrt(B), sob = S/B, asimov
+// Each cut costs O(1) through summed-area tables; the grid of cuts is
+// searched on nThreads threads (0: all cores). Scans of more than
+// kMaxCandidates cut sets are refused rather than left running.
+inline std::vector<CutCandidate> optimizeCuts (TString text_file, TString histName, int nTop = 10,
+                                               TString metric = "signif", bool windows = true, int nThreads = 0) {
+  std::vector<CutCandidate> best;
+  auto score = cutMetric(metric);
+  if (!score) {
+    std::cerr << "Unknown metric: " << metric << std::endl;
+    return best;
+  }
+  if (nTop < 1) {
+    std::cerr << "nTop must be at least 1" << std::endl;
+    return best;
+  }
+
+  std::vector<std::string> lines;
+  read_lines(text_file.Data(), lines);
+  std::vector<TString> paths;
+  for (auto& ln: lines) paths.push_back(TString(ln) + "_hist.root");
+  auto objs = sampleLoader().Load(paths, {histName});
+
+  // The signal is positional: paths[0], never the first file that happened to load
+  DenseGrid sigGrid, bkgGrid;
+  std::vector<const TAxis*> axes;
+  if (paths.empty() || !objs[0][0]) {
+    std::cerr << "No signal " << histName << " in " << (paths.empty() ? TString("") : paths[0]) << std::endl;
+    return best;
+  }
+  std::cout<<paths[0]<<"\n";
+  if (!toDenseGrid(objs[0][0].get(), sigGrid, axes)) {
+    std::cerr << histName << " in " << paths[0] << " is not a TH1/TH2/TH3/THnBase" << std::endl;
+    return best;
+  }
+  std::unique_ptr<TObject> sigObj = std::move(objs[0][0]);  // keeps the signal axes alive
+  bkgGrid = DenseGrid(sigGrid.nBins);
+  size_t nBkg = 0;
+  for (size_t ip = 1; ip < paths.size(); ++ip) {
+    std::cout<<paths[ip]<<"\n";
+    if (!objs[ip][0]) continue;
+    DenseGrid grid;
+    std::vector<const TAxis*> ax;
+    if (!toDenseGrid(objs[ip][0].get(), grid, ax)) {
+      std::cerr << histName << " in " << paths[ip] << " is not a TH1/TH2/TH3/THnBase" << std::endl;
+      continue;
+    }
+    if (grid.nBins != sigGrid.nBins) {
+      std::cerr << histName << " in " << paths[ip] << " does not have the signal binning, skipped" << std::endl;
+      continue;
+    }
+    bkgGrid.Add(grid);
+    ++nBkg;
+  }
+  if (nBkg == 0) {
+    std::cerr << "optimizeCuts needs at least one background" << std::endl;
+    return best;
+  }
+
+  const SummedAreaTable sigTable(sigGrid);
+  const SummedAreaTable bkgTable(bkgGrid);
+
+  // Counted before anything is built: n(n+1)/2 windows or 2n-3 one-sided
+  // cuts per axis of n stored bins, multiplied over the axes
+  size_t nCand = 1;
+  for (size_t d = 0; d < axes.size(); ++d) {
+    const size_t n = sigGrid.nBins[d];
+    const size_t perAxis = windows ? n*(n+1)/2 : 2*n - 3;
+    if (nCand > kMaxCandidates/perAxis) {
+      std::cerr << axes.size() << "-d " << (windows ? "window" : "one-sided") << " scan exceeds "
+                << kMaxCandidates << " cut sets; "
+                << (windows ? "use windows=false, or rebin" : "rebin or project out an axis") << std::endl;
+      return best;
+    }
+    nCand *= perAxis;
+  }
+
+  std::vector<std::vector<std::pair<int,int>>> choices(axes.size());
+  for (size_t d = 0; d < axes.size(); ++d) {
+    const int last = sigGrid.nBins[d] - 1;  // overflow bin
+    if (windows) {
+      for (int lo = 0; lo <= last; ++lo)
+        for (int hi = lo; hi <= last; ++hi) choices[d].push_back({lo, hi});
+    }
+    else {
+      choices[d].push_back({0, last});
+      for (int k = 1; k < last; ++k) {
+        choices[d].push_back({0, k});     // MinToX
+        choices[d].push_back({k, last});  // XToMax
+      }
+    }
+  }
+  std::cout << axes.size() << "-d " << (windows ? "window" : "one-sided") << " scan over "
+            << nCand << " cut sets, " << nBkg << " backgrounds\n";
+
+  best = searchCuts(sigTable, bkgTable, choices, score, nTop, nThreads);
+
+  auto edge = [](const TAxis* ax, int bin, bool low) {
+    if (bin == 0 && low) return -std::numeric_limits<double>::infinity();
+    if (bin == ax->GetNbins() + 1 && !low) return std::numeric_limits<double>::infinity();
+    return low ? ax->GetBinLowEdge(bin) : ax->GetBinUpEdge(bin);
+  };
+  std::cout<<"Rank"<<std::setw(16)<<metric<<std::setw(16)<<"S"<<std::setw(16)<<"B"<<"   Cuts\n";
+  for (size_t ib = 0; ib < best.size(); ++ib) {
+    const CutCandidate& c = best[ib];
+    std::cout<<std::setprecision(5)<<std::setw(4)<<ib+1<<std::setw(16)<<c.score
+             <<std::setw(16)<<c.S<<std::setw(16)<<c.B<<"  ";
+    for (size_t d = 0; d < axes.size(); ++d) {
+      if (c.lo[d] == 0 && c.hi[d] == sigGrid.nBins[d] - 1) continue;
+      const char* name = strlen(axes[d]->GetTitle()) ? axes[d]->GetTitle() : axes[d]->GetName();
+      std::cout<<" "<<edge(axes[d], c.lo[d], true)<<" <= "<<name<<" < "<<edge(axes[d], c.hi[d], false)<<";";
+    }
+    std::cout<<"\n";
+  }
+  return best;
+}
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef CUTSCAN_H
+#define CUTSCAN_H
+
+#include <TH1.h>
+#include <TMath.h>
+
+#include <vector>
+
+// Figures of merit for every one-sided cut on a binned variable.
+// Vectors are indexed like the histogram bins (1..nBins), entry 0 is unused.
+struct CutScanPoints {
+  std::vector<float> S;
+  std::vector<float> B;
+  std::vector<float> sigEff;
+  std::vector<float> bkgEff;
+  std::vector<float> bkgRej;
+  std::vector<float> sigPur;
+  std::vector<float> sigPurEff;
+  std::vector<float> signf;
+
+  void resize(int n) {
+    for (auto v : {&S, &B, &sigEff, &bkgEff, &bkgRej, &sigPur, &sigPurEff, &signf})
+      v->assign(n, 0.0);
+  }
+};
+
+struct CutScan {
+  int nBins = 0;
+  double sigTotal = 0.0;
+  float bkgTotal = 0.0;
+  CutScanPoints minToX;   // keep [underflow, ib]  == Integral(0, ib)
+  CutScanPoints xToMax;   // keep [ib, nBins]      == Integral(ib, nBins)
+
+  // Same precedence as the old per-bin loops: XToMax wins over MinToX
+  const CutScanPoints* select(bool MinToX, bool XToMax) const {
+    if (XToMax) return &xToMax;
+    if (MinToX) return &minToX;
+    return nullptr;
+  }
+};
+
+// Builds the cumulative sums of the signal (hvec[0]) and of the summed
+// backgrounds (hvec[1..]) once, so every cut point costs O(1) instead of a
+// fresh TH1::Integral per bin and per sample. The float/double mix of the
+// old loops is kept on purpose so the numbers printed and plotted stay the same.
+template <typename H>
+CutScan scanCuts(const std::vector<H*>& hvec) {
+  CutScan scan;
+  if (hvec.empty()) return scan;
+
+  const int nBins = hvec[0]->GetNbinsX();
+  scan.nBins = nBins;
+  scan.minToX.resize(nBins+1);
+  scan.xToMax.resize(nBins+1);
+
+  std::vector<double> prefix(nBins+1);
+  std::vector<double> suffix(nBins+2);
+  for (size_t ih = 0; ih < hvec.size(); ++ih) {
+    const H* h = hvec[ih];
+    double sum = 0.0;
+    for (int ib = 0; ib <= nBins; ++ib) {
+      sum += h->GetBinContent(ib);
+      prefix[ib] = sum;
+    }
+    sum = 0.0;
+    suffix[nBins+1] = 0.0;
+    for (int ib = nBins; ib >= 1; --ib) {
+      sum += h->GetBinContent(ib);
+      suffix[ib] = sum;
+    }
+
+    if (ih == 0) {
+      scan.sigTotal = h->Integral();
+      for (int ib = 1; ib <= nBins; ++ib) {
+        scan.minToX.S[ib] = prefix[ib];
+        scan.xToMax.S[ib] = suffix[ib];
+      }
+      continue;
+    }
+    scan.bkgTotal += h->Integral();
+    for (int ib = 1; ib <= nBins; ++ib) {
+      scan.minToX.B[ib] += prefix[ib];
+      scan.xToMax.B[ib] += suffix[ib];
+    }
+  }
+
+  for (auto p : {&scan.minToX, &scan.xToMax}) {
+    for (int ib = 1; ib <= nBins; ++ib) {
+      float S = p->S[ib];
+      float B = p->B[ib];
+      p->signf[ib]     = S/TMath::Sqrt(S+B);
+      p->sigEff[ib]    = S/scan.sigTotal;
+      p->bkgEff[ib]    = B/scan.bkgTotal;
+      p->bkgRej[ib]    = 1.0 - p->bkgEff[ib];
+      p->sigPur[ib]    = S/(S+B);
+      p->sigPurEff[ib] = p->sigPur[ib]*p->sigEff[ib];
+    }
+  }
+  return scan;
+}
+
+#endif
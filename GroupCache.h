@@ -0,0 +1,146 @@
+#ifndef GROUPCACHE_H
+#define GROUPCACHE_H
+
+#include <TDirectory.h>
+#include <TFile.h>
+#include <TH1.h>
+#include <TNamed.h>
+#include <TString.h>
+#include <TSystem.h>
+
+#include <cctype>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SampleList.h"
+#include "SampleLoader.h"
+
+// A named set of samples whose histograms are summed, e.g. one class of backgrounds
+struct SampleGroup {
+  std::string name;
+  std::vector<std::string> members;
+};
+
+// Group files use the read_lines format, one group per line:
+//   <group> <sample> [<sample> ...]
+// A line with a single name is a group holding just that sample, so a
+// plain sample list is also a valid group file.
+inline std::vector<SampleGroup> read_groups(std::string tname) {
+  std::vector<std::string> lines;
+  read_lines(tname, lines);
+  std::vector<SampleGroup> groups;
+  for (auto& ln: lines) {
+    std::istringstream is(ln);
+    SampleGroup g;
+    is >> g.name;
+    for (std::string m; is >> m; ) g.members.push_back(m);
+    if (g.members.empty()) g.members.push_back(g.name);
+    groups.push_back(g);
+  }
+  return groups;
+}
+
+// Merged, rebinned group histograms cached in one small ROOT file. Each
+// entry is stored with a stamp of its member files (path, size, mtime); an
+// entry is rebuilt from the sample files only when its stamp changed.
+class GroupCache {
+public:
+  explicit GroupCache(TString cacheFile = "groupcache.root") : fCacheFile(cacheFile) {}
+
+  // One detached histogram per group (nullptr if no member had histName)
+  std::vector<std::unique_ptr<TH1D>> Get(const std::vector<SampleGroup>& groups, const TString& suffix,
+                                         const TString& histName, int rebin) {
+    TDirectory::TContext ctx;
+    std::vector<std::unique_ptr<TH1D>> out(groups.size());
+    std::vector<TString> keys, stamps;
+    std::vector<size_t> stale;
+
+    std::unique_ptr<TFile> cache;
+    if (!gSystem->AccessPathName(fCacheFile)) cache.reset(TFile::Open(fCacheFile, "READ"));
+    for (size_t ig = 0; ig < groups.size(); ++ig) {
+      keys.push_back(Key(groups[ig].name, suffix, histName, rebin));
+      stamps.push_back(Stamp(groups[ig], suffix, histName, rebin));
+      auto stored = cache ? dynamic_cast<TNamed*>(cache->Get(keys[ig] + "_stamp")) : nullptr;
+      auto h = (stored && stamps[ig] == stored->GetTitle()) ? dynamic_cast<TH1D*>(cache->Get(keys[ig])) : nullptr;
+      if (h) {
+        h->SetDirectory(nullptr);
+        out[ig].reset(h);
+      }
+      else stale.push_back(ig);
+      delete stored;
+    }
+    cache.reset();
+    if (stale.empty()) return out;
+
+    // All member files of all stale groups are read in one parallel pass
+    std::vector<TString> paths;
+    for (size_t ig : stale)
+      for (auto& m: groups[ig].members) paths.push_back(TString(m) + suffix);
+    auto objs = sampleLoader().Load(paths, {histName});
+
+    cache.reset(TFile::Open(fCacheFile, "UPDATE"));
+    size_t ip = 0;
+    for (size_t ig : stale) {
+      std::unique_ptr<TH1D> sum;
+      for (size_t im = 0; im < groups[ig].members.size(); ++im, ++ip) {
+        auto h = dynamic_cast<TH1D*>(objs[ip][0].get());
+        if (!h) continue;
+        if (!sum) {
+          sum.reset(static_cast<TH1D*>(h->Clone(groups[ig].name.c_str())));
+          sum->SetDirectory(nullptr);
+        }
+        else sum->Add(h);
+      }
+      if (!sum) continue;
+      if (rebin > 1) sum->Rebin(rebin);
+      if (cache && !cache->IsZombie()) {
+        cache->cd();
+        sum->Write(keys[ig], TObject::kOverwrite);
+        TNamed(keys[ig] + "_stamp", stamps[ig]).Write(nullptr, TObject::kOverwrite);
+      }
+      std::cout<<"cached "<<groups[ig].name<<" ("<<groups[ig].members.size()<<" samples) "<<histName<<"\n";
+      out[ig] = std::move(sum);
+    }
+    return out;
+  }
+
+private:
+  static TString Identity(const std::string& group, const TString& suffix, const TString& histName, int rebin) {
+    return TString::Format("%s|%s|%s|%d", group.c_str(), suffix.Data(), histName.Data(), rebin);
+  }
+
+  // Readable key name plus a hash of the exact identity, so that e.g. l1.pt and
+  // l1_pt get different keys; the identity itself is checked through the stamp
+  static TString Key(const std::string& group, const TString& suffix, const TString& histName, int rebin) {
+    const TString id = Identity(group, suffix, histName, rebin);
+    TString key = TString::Format("%s__%s__%s__%d", group.c_str(), suffix.Data(), histName.Data(), rebin);
+    for (Ssiz_t i = 0; i < key.Length(); ++i)
+      if (!isalnum(key[i])) key[i] = '_';
+    return key + TString::Format("__%08x", id.Hash());
+  }
+
+  // Unsanitised identity, then path:size:mtime of every member file
+  static TString Stamp(const SampleGroup& g, const TString& suffix, const TString& histName, int rebin) {
+    TString stamp = Identity(g.name, suffix, histName, rebin) + ";";
+    for (auto& m: g.members) {
+      TString path = TString(m) + suffix;
+      FileStat_t st;
+      if (gSystem->GetPathInfo(path, st) != 0) stamp += TString::Format("%s:missing;", path.Data());
+      else stamp += TString::Format("%s:%lld:%ld;", path.Data(), st.fSize, st.fMtime);
+    }
+    return stamp;
+  }
+
+  TString fCacheFile;
+};
+
+// Cache shared by all plotting calls of a session
+inline GroupCache& groupCache() {
+  static GroupCache cache;
+  return cache;
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef IMPLICITMT_H
+#define IMPLICITMT_H
+
+#include <TROOT.h>
+
+// Enables implicit MT for its lifetime unless it already is (nThreads: 0 = all
+// cores, 1 = stay serial), then restores the previous state
+struct ImplicitMTScope {
+  bool wasEnabled;
+  explicit ImplicitMTScope(int nThreads) : wasEnabled(ROOT::IsImplicitMTEnabled()) {
+    if (!wasEnabled && nThreads != 1) ROOT::EnableImplicitMT(nThreads);
+  }
+  ~ImplicitMTScope() {
+    if (!wasEnabled && ROOT::IsImplicitMTEnabled()) ROOT::DisableImplicitMT();
+  }
+};
+
+#endif
@@ -0,0 +1,300 @@
+#ifndef MVASCORE_H
+#define MVASCORE_H
+
+#include <TROOT.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TBranch.h>
+#include <TBufferFile.h>
+#include <TLeaf.h>
+#include <TH1F.h>
+#include <TMath.h>
+#include <TString.h>
+#include <TTreeFormula.h>
+#include <TXMLEngine.h>
+#include <Bytes.h>
+
+#include "TMVA/Reader.h"
+
+#include "QuantileSketch.h"
+#include "RocCurve.h"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Input and spectator expressions of a TMVA weight file, in booking order,
+// with the TMVA type of each variable ('F' or 'I')
+struct MVAInputs {
+  std::vector<TString> variables;
+  std::vector<char> types;
+  std::vector<TString> spectators;
+};
+
+// Reads <Variables> and <Spectators> from the weight-file XML, so the
+// Reader is booked with exactly what the method was trained on
+inline MVAInputs readWeightFileInputs(const TString& weightfile) {
+  MVAInputs inputs;
+  TXMLEngine xml;
+  XMLDocPointer_t doc = xml.ParseFile(weightfile);
+  if (!doc) {
+    std::cerr << "Weight file: " << weightfile << " could not be parsed!" << std::endl;
+    return inputs;
+  }
+  XMLNodePointer_t root = xml.DocGetRootElement(doc);
+  for (XMLNodePointer_t node = xml.GetChild(root); node; node = xml.GetNext(node)) {
+    TString section = xml.GetNodeName(node);
+    std::vector<TString>* list = nullptr;
+    if (section == "Variables") list = &inputs.variables;
+    else if (section == "Spectators") list = &inputs.spectators;
+    else continue;
+    for (XMLNodePointer_t var = xml.GetChild(node); var; var = xml.GetNext(var)) {
+      list->push_back(xml.GetAttr(var, "Expression"));
+      if (list != &inputs.variables) continue;
+      const char* type = xml.GetAttr(var, "Type");
+      inputs.types.push_back(type && *type ? type[0] : 'F');
+    }
+  }
+  xml.FreeDoc(doc);
+  return inputs;
+}
+
+// Optional unbinned outputs of fillResponse, appended to if set
+struct ResponseOutput {
+  std::vector<ScoredEvent>* scores = nullptr;  // every response, in entry order
+  QuantileSketch* sketch = nullptr;            // bounded-memory summary
+};
+
+// nReaders TMVA Readers booked once from one weight file and reused for every
+// file and tree scored with it; worker i of fillResponse uses reader i.
+struct MVAReaderPool {
+  TString methodName;
+  std::vector<std::unique_ptr<TMVA::Reader>> readers;
+  std::vector<std::vector<float>> vars;        // per reader, bound to its inputs
+  std::vector<std::vector<float>> spectators;
+
+  // Booking is serial: TMVA booking is not thread safe
+  bool Book(const MVAInputs& inputs, const TString& method, const TString& weightfile, int nReaders) {
+    methodName = method;
+    nReaders = std::max(nReaders, 1);
+    readers.clear();
+    vars.assign(nReaders, std::vector<float>(inputs.variables.size()));
+    spectators.assign(nReaders, std::vector<float>(inputs.spectators.size()));
+    for (int ir = 0; ir < nReaders; ++ir) {
+      auto reader = std::make_unique<TMVA::Reader>(ir == 0 ? "!Color:!Silent" : "!Color:Silent");
+      for (size_t iv = 0; iv < inputs.variables.size(); ++iv)
+        reader->AddVariable(inputs.variables[iv], &vars[ir][iv]);
+      for (size_t is = 0; is < inputs.spectators.size(); ++is)
+        reader->AddSpectator(inputs.spectators[is], &spectators[ir][is]);
+      if (!reader->BookMVA(methodName, weightfile)) {
+        std::cerr << methodName << " could not be booked from " << weightfile << std::endl;
+        readers.clear();
+        return false;
+      }
+      readers.push_back(std::move(reader));
+    }
+    return true;
+  }
+};
+
+// One Reader input of one worker, read into a column of consecutive entries.
+// A plain Float_t branch is read a whole basket at a time through the bulk
+// API (TBranch::GetBulkRead), with no per-entry GetEntry call. Anything else
+// (integer inputs, formulas, branches the bulk API refuses) is evaluated per
+// entry with a TTreeFormula and converted to float, as TMVA does itself.
+struct InputColumn {
+  TBranch* branch = nullptr;
+  std::unique_ptr<TTreeFormula> formula;
+  TBufferFile buffer{TBuffer::kWrite, 32*1024};
+  std::vector<float> basket;  // entries [basketFirst, basketFirst + basket.size())
+  Long64_t basketFirst = 0;
+  float slot = 0;             // per-entry fallback if a bulk read fails
+
+  void Read(TTree* tree, Long64_t first, Long64_t n, float* out) {
+    Long64_t done = 0;
+    while (branch && done < n) {
+      const Long64_t e = first + done;
+      if ((e < basketFirst || e >= basketFirst + Long64_t(basket.size())) && !LoadBasket(e)) {
+        branch->SetAddress(&slot);
+        for (; done < n; ++done) {
+          branch->GetEntry(first + done);
+          out[done] = slot;
+        }
+        return;
+      }
+      const Long64_t k = std::min<Long64_t>(n - done, basketFirst + Long64_t(basket.size()) - e);
+      std::copy_n(basket.data() + (e - basketFirst), k, out + done);
+      done += k;
+    }
+    for (; done < n; ++done) {
+      tree->LoadTree(first + done);
+      formula->GetNdata();
+      out[done] = formula->EvalInstance();
+    }
+  }
+
+  // Bulk reads must start at the first entry of a basket
+  bool LoadBasket(Long64_t entry) {
+    const Long64_t* starts = branch->GetBasketEntry();
+    const Long64_t ib = TMath::BinarySearch(Long64_t(branch->GetWriteBasket()) + 1, starts, entry);
+    if (ib < 0) return false;
+    const Int_t count = branch->GetBulkRead().GetEntriesSerialized(starts[ib], buffer);
+    if (count <= 0 || starts[ib] + count <= entry) return false;
+    basketFirst = starts[ib];
+    basket.resize(count);
+    char* p = buffer.GetCurrent();
+    for (Int_t i = 0; i < count; ++i) frombuf(p, &basket[i]);  // big-endian on disk
+    return true;
+  }
+};
+
+// One scoring worker: its own file handle, tree and response histogram, and
+// one Reader of the pool, so nothing is shared between threads while the loop runs.
+// Inputs are read into one column per variable (blockSize entries at a time,
+// see InputColumn); the Reader API still takes one event at a time.
+struct MVAScoreWorker {
+  static constexpr Long64_t blockSize = 4096;
+
+  std::unique_ptr<TFile> file;
+  TTree* tree = nullptr;
+  TMVA::Reader* reader = nullptr;
+  std::vector<float>* vars = nullptr;
+  std::vector<std::unique_ptr<InputColumn>> inputs;
+  std::vector<std::vector<float>> columns;
+  std::unique_ptr<TH1F> hist;
+  std::vector<ScoredEvent> scores;
+  std::unique_ptr<QuantileSketch> sketch;
+  bool keepScores = false;
+  Long64_t first = 0;
+  Long64_t last  = 0;
+
+  void run(const TString& methodName) {
+    for (Long64_t b = first; b < last; b += blockSize) {
+      const Long64_t n = std::min(blockSize, last - b);
+      for (size_t iv = 0; iv < inputs.size(); ++iv) inputs[iv]->Read(tree, b, n, columns[iv].data());
+      for (Long64_t i = 0; i < n; ++i) {
+        for (size_t iv = 0; iv < vars->size(); ++iv) (*vars)[iv] = columns[iv][i];
+        const double response = reader->EvaluateMVA(methodName);
+        if (hist) hist->Fill(response);
+        if (keepScores) scores.push_back({static_cast<float>(response), 1.0f});
+        if (sketch) sketch->Fill(response);
+      }
+    }
+  }
+};
+
+// Splits [0, nEntries) into at most nParts contiguous ranges that start on
+// cluster boundaries, so two workers never decompress the same basket.
+inline std::vector<Long64_t> clusterRanges(TTree* tree, int nParts) {
+  const Long64_t nEntries = tree->GetEntries();
+  std::vector<Long64_t> starts;
+  auto it = tree->GetClusterIterator(0);
+  for (Long64_t s = it(); s < nEntries; s = it()) starts.push_back(s);
+
+  std::vector<Long64_t> edges = {0};
+  for (int ip = 1; ip < nParts; ++ip) {
+    const Long64_t target = nEntries*ip/nParts;
+    auto lb = std::lower_bound(starts.begin(), starts.end(), target);
+    if (lb == starts.end()) break;
+    if (*lb > edges.back()) edges.push_back(*lb);
+  }
+  edges.push_back(nEntries);
+  return edges;
+}
+
+// Fills hist with the response of the pool's method for every entry of
+// treeName, on one worker per reader of the pool. Each worker opens its own
+// file handle and reads only the input branches. Per-worker histograms are
+// added at the end, which gives the same bin contents as the serial loop.
+// hist may be nullptr when only the unbinned outputs are wanted.
+inline bool fillResponse(TH1F* hist, const TString& fileName, const TString& treeName,
+                         const MVAInputs& inputs, MVAReaderPool& pool,
+                         ResponseOutput out = {}) {
+  int nThreads = pool.readers.size();
+  if (nThreads < 1) return false;
+  if (nThreads > 1) ROOT::EnableThreadSafety();
+
+  std::vector<std::unique_ptr<MVAScoreWorker>> workers;
+  std::vector<Long64_t> edges;
+  for (int iw = 0; iw < nThreads; ++iw) {
+    auto w = std::make_unique<MVAScoreWorker>();
+    w->file.reset(TFile::Open(fileName));
+    if (!w->file || w->file->IsZombie()) {
+      std::cerr << fileName << " could not be opened!" << std::endl;
+      return false;
+    }
+    w->tree = dynamic_cast<TTree*>(w->file->Get(treeName));
+    if (!w->tree) {
+      std::cerr << treeName << " not found in " << fileName << std::endl;
+      return false;
+    }
+    if (iw == 0) {
+      edges = clusterRanges(w->tree, nThreads);
+      nThreads = edges.size() - 1;
+    }
+    w->first = edges[iw];
+    w->last  = edges[iw+1];
+
+    w->reader = pool.readers[iw].get();
+    w->vars = &pool.vars[iw];
+    w->columns.assign(inputs.variables.size(), std::vector<float>(MVAScoreWorker::blockSize));
+    w->tree->SetCacheSize(10*1024*1024);
+    for (size_t iv = 0; iv < inputs.variables.size(); ++iv) {
+      const TString& name = inputs.variables[iv];
+      auto col = std::make_unique<InputColumn>();
+      TBranch* br = w->tree->GetBranch(name);
+      TLeaf* leaf = br && br->GetListOfLeaves()->GetEntriesFast() == 1 ? static_cast<TLeaf*>(br->GetListOfLeaves()->At(0)) : nullptr;
+      if (inputs.types[iv] == 'F' && leaf && TString(leaf->GetTypeName()) == "Float_t" &&
+          leaf->GetLenStatic() == 1 && !leaf->GetLeafCount() && br->SupportsBulkRead()) {
+        col->branch = br;
+        w->tree->AddBranchToCache(br);
+      }
+      else {
+        col->formula = std::make_unique<TTreeFormula>(TString::Format("MVAInput%zu", iv), name, w->tree);
+        if (col->formula->GetNdim() == 0) {
+          std::cerr << "Variable " << name << " cannot be evaluated on " << fileName << ":" << treeName << std::endl;
+          return false;
+        }
+        for (Int_t il = 0; il < col->formula->GetNcodes(); ++il)
+          if (TLeaf* l = col->formula->GetLeaf(il)) w->tree->AddBranchToCache(l->GetBranch());
+      }
+      w->inputs.push_back(std::move(col));
+    }
+    w->tree->StopCacheLearningPhase();
+    w->tree->SetCacheEntryRange(w->first, w->last);
+
+    if (hist) {
+      w->hist.reset(static_cast<TH1F*>(hist->Clone()));
+      w->hist->SetDirectory(nullptr);
+      w->hist->Reset();
+    }
+    w->keepScores = out.scores != nullptr;
+    if (out.sketch) w->sketch = std::make_unique<QuantileSketch>(out.sketch->Compression());
+    workers.push_back(std::move(w));
+  }
+
+  if (workers.size() == 1) {
+    workers[0]->run(pool.methodName);
+  }
+  else {
+    std::vector<std::thread> threads;
+    for (auto& w : workers) threads.emplace_back([&w, &pool] { w->run(pool.methodName); });
+    for (auto& t : threads) t.join();
+  }
+
+  if (hist)
+    for (auto& w : workers) hist->Add(w->hist.get());
+  if (out.scores)
+    for (auto& w : workers) out.scores->insert(out.scores->end(), w->scores.begin(), w->scores.end());
+  if (out.sketch) {
+    std::vector<QuantileSketch> parts = {std::move(*out.sketch)};
+    for (auto& w : workers) parts.push_back(std::move(*w->sketch));
+    mergeSketches(parts);
+    *out.sketch = std::move(parts[0]);
+  }
+  return true;
+}
+
+#endif
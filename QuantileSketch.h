@@ -0,0 +1,129 @@
+#ifndef QUANTILESKETCH_H
+#define QUANTILESKETCH_H
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <vector>
+
+// Mergeable, weighted quantile summary (merging t-digest). Memory stays at
+// about compression/2 centroids whatever the number of entries (250-290 for
+// the default 500 with the k1 scale function), and the
+// centroids get smaller towards both tails, where the high-purity end of a
+// ROC curve lives. Two sketches built on disjoint inputs can be merged.
+class QuantileSketch {
+public:
+  struct Centroid {
+    double mean;
+    double weight;
+  };
+
+  explicit QuantileSketch(double compression = 500) : fDelta(compression) {}
+
+  void Fill(double x, double w = 1.0) {
+    if (w <= 0) return;
+    fBuffer.push_back({x, w});
+    fMin = std::min(fMin, x);
+    fMax = std::max(fMax, x);
+    if (fBuffer.size() >= 8*fDelta) Compress();
+  }
+
+  void Merge(const QuantileSketch& o) {
+    fBuffer.insert(fBuffer.end(), o.fCentroids.begin(), o.fCentroids.end());
+    fBuffer.insert(fBuffer.end(), o.fBuffer.begin(), o.fBuffer.end());
+    fMin = std::min(fMin, o.fMin);
+    fMax = std::max(fMax, o.fMax);
+    Compress();
+  }
+
+  double Total() {
+    Compress();
+    return fTotal;
+  }
+
+  double Compression() const { return fDelta; }
+  double Min() const { return fMin; }
+  double Max() const { return fMax; }
+
+  const std::vector<Centroid>& Centroids() {
+    Compress();
+    return fCentroids;
+  }
+
+  // Weight below x, linear between the centroid means (each centroid's
+  // weight is taken as half below and half above its mean)
+  double Below(double x) {
+    Compress();
+    if (fCentroids.empty() || x <= fMin) return 0.0;
+    if (x >= fMax) return fTotal;
+    double cum = 0.0;
+    double xl = fMin;
+    double yl = 0.0;
+    for (const auto& c : fCentroids) {
+      const double yr = cum + 0.5*c.weight;
+      if (x < c.mean) return c.mean > xl ? yl + (yr - yl)*(x - xl)/(c.mean - xl) : yl;
+      cum += c.weight;
+      xl = c.mean;
+      yl = yr;
+    }
+    return fMax > xl ? yl + (fTotal - yl)*(x - xl)/(fMax - xl) : fTotal;
+  }
+
+private:
+  // Scale function k1: centroid q-widths shrink like sqrt(q(1-q)) at the tails
+  double K(double q) const { return fDelta/(2*M_PI)*std::asin(2*q - 1); }
+  double KInv(double k) const {
+    k = std::min(std::max(k, -fDelta/4), fDelta/4);
+    return 0.5*(std::sin(k*2*M_PI/fDelta) + 1);
+  }
+
+  void Compress() {
+    if (fBuffer.empty()) return;
+    fBuffer.insert(fBuffer.end(), fCentroids.begin(), fCentroids.end());
+    std::sort(fBuffer.begin(), fBuffer.end(),
+              [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+    double total = 0.0;
+    for (const auto& c : fBuffer) total += c.weight;
+
+    fCentroids.clear();
+    Centroid cur = fBuffer[0];
+    double wSoFar = cur.weight;
+    double wLimit = total*KInv(K(0.0) + 1);
+    for (size_t i = 1; i < fBuffer.size(); ++i) {
+      const Centroid& c = fBuffer[i];
+      if (wSoFar + c.weight <= wLimit) {
+        cur.mean += (c.mean - cur.mean)*c.weight/(cur.weight + c.weight);
+        cur.weight += c.weight;
+      }
+      else {
+        fCentroids.push_back(cur);
+        wLimit = total*KInv(K(wSoFar/total) + 1);
+        cur = c;
+      }
+      wSoFar += c.weight;
+    }
+    fCentroids.push_back(cur);
+    fTotal = total;
+    fBuffer.clear();
+  }
+
+  double fDelta;
+  double fTotal = 0.0;
+  double fMin = std::numeric_limits<double>::infinity();
+  double fMax = -std::numeric_limits<double>::infinity();
+  std::vector<Centroid> fCentroids;
+  std::vector<Centroid> fBuffer;
+};
+
+// Pairwise tree merge, each level merged concurrently; the result is left in sketches[0]
+inline void mergeSketches(std::vector<QuantileSketch>& sketches) {
+  for (size_t step = 1; step < sketches.size(); step *= 2) {
+    std::vector<std::future<void>> level;
+    for (size_t i = 0; i + step < sketches.size(); i += 2*step)
+      level.push_back(std::async(std::launch::async, [&sketches, i, step] { sketches[i].Merge(sketches[i+step]); }));
+    for (auto& f : level) f.get();
+  }
+}
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef ROCCURVE_H
+#define ROCCURVE_H
+
+#include <TGraph.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "QuantileSketch.h"
+
+struct ScoredEvent {
+  float score;
+  float weight;
+};
+
+struct RocResult {
+  std::vector<double> sigEff;
+  std::vector<double> bkgRej;
+  double auc = 0.0;
+
+  // Caller owns the graph
+  TGraph* MakeGraph(const char* name) const {
+    TGraph* g = new TGraph(sigEff.size(), sigEff.data(), bkgRej.data());
+    g->SetName(name);
+    return g;
+  }
+};
+
+// Exact ROC: one point per distinct score, cutting score >= threshold from
+// the top down. auc is the area under bkgRej vs sigEff, i.e. the probability
+// that signal scores above background, ties counted as one half.
+inline RocResult exactRoc(const std::vector<ScoredEvent>& sig, const std::vector<ScoredEvent>& bkg) {
+  struct Labelled {
+    float score;
+    float weight;
+    bool signal;
+  };
+  std::vector<Labelled> all;
+  all.reserve(sig.size() + bkg.size());
+  double totS = 0.0, totB = 0.0;
+  for (const auto& e : sig) { all.push_back({e.score, e.weight, true});  totS += e.weight; }
+  for (const auto& e : bkg) { all.push_back({e.score, e.weight, false}); totB += e.weight; }
+  std::sort(all.begin(), all.end(), [](const Labelled& a, const Labelled& b) { return a.score > b.score; });
+
+  RocResult roc;
+  if (totS <= 0 || totB <= 0) return roc;
+  double S = 0.0, B = 0.0;
+  roc.sigEff.push_back(0.0);
+  roc.bkgRej.push_back(1.0);
+  for (size_t i = 0; i < all.size(); ) {
+    const float score = all[i].score;
+    for (; i < all.size() && all[i].score == score; ++i) (all[i].signal ? S : B) += all[i].weight;
+    const double eff = S/totS, rej = 1.0 - B/totB;
+    roc.auc += (eff - roc.sigEff.back())*(rej + roc.bkgRej.back())/2;
+    roc.sigEff.push_back(eff);
+    roc.bkgRej.push_back(rej);
+  }
+  return roc;
+}
+
+// Weighted two-sample Kolmogorov-Smirnov distance sup|F_a - F_b|
+inline double exactKS(std::vector<ScoredEvent> a, std::vector<ScoredEvent> b) {
+  auto byScore = [](const ScoredEvent& x, const ScoredEvent& y) { return x.score < y.score; };
+  std::sort(a.begin(), a.end(), byScore);
+  std::sort(b.begin(), b.end(), byScore);
+  double totA = 0.0, totB = 0.0;
+  for (const auto& e : a) totA += e.weight;
+  for (const auto& e : b) totB += e.weight;
+  if (totA <= 0 || totB <= 0) return 0.0;
+
+  double fa = 0.0, fb = 0.0, d = 0.0;
+  size_t ia = 0, ib = 0;
+  while (ia < a.size() || ib < b.size()) {
+    const float x = (ib == b.size() || (ia < a.size() && a[ia].score <= b[ib].score)) ? a[ia].score : b[ib].score;
+    for (; ia < a.size() && a[ia].score == x; ++ia) fa += a[ia].weight/totA;
+    for (; ib < b.size() && b[ib].score == x; ++ib) fb += b[ib].weight/totB;
+    d = std::max(d, std::fabs(fa - fb));
+  }
+  return d;
+}
+
+// Thresholds at which two sketches are compared: every centroid mean and both ends
+inline std::vector<double> sketchKnots(QuantileSketch& a, QuantileSketch& b) {
+  std::vector<double> knots;
+  for (auto s : {&a, &b}) {
+    for (const auto& c : s->Centroids()) knots.push_back(c.mean);
+    knots.push_back(s->Min());
+    knots.push_back(s->Max());
+  }
+  std::sort(knots.begin(), knots.end());
+  knots.erase(std::unique(knots.begin(), knots.end()), knots.end());
+  return knots;
+}
+
+// Approximate ROC from two sketches, with the same conventions as exactRoc
+inline RocResult sketchRoc(QuantileSketch& sig, QuantileSketch& bkg) {
+  RocResult roc;
+  const double totS = sig.Total(), totB = bkg.Total();
+  if (totS <= 0 || totB <= 0) return roc;
+  const std::vector<double> knots = sketchKnots(sig, bkg);
+  roc.sigEff.push_back(0.0);
+  roc.bkgRej.push_back(1.0);
+  for (auto it = knots.rbegin(); it != knots.rend(); ++it) {
+    const double eff = 1.0 - sig.Below(*it)/totS;
+    const double rej = bkg.Below(*it)/totB;
+    roc.auc += (eff - roc.sigEff.back())*(rej + roc.bkgRej.back())/2;
+    roc.sigEff.push_back(eff);
+    roc.bkgRej.push_back(rej);
+  }
+  roc.auc += (1.0 - roc.sigEff.back())*roc.bkgRej.back()/2;
+  roc.sigEff.push_back(1.0);
+  roc.bkgRej.push_back(0.0);
+  return roc;
+}
+
+inline double sketchKS(QuantileSketch& a, QuantileSketch& b) {
+  const double totA = a.Total(), totB = b.Total();
+  if (totA <= 0 || totB <= 0) return 0.0;
+  double d = 0.0;
+  for (double x : sketchKnots(a, b)) d = std::max(d, std::fabs(a.Below(x)/totA - b.Below(x)/totB));
+  return d;
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef SAMPLELIST_H
+#define SAMPLELIST_H
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Sample lists are plain text, one sample name per line (no suffix);
+// empty lines and lines starting with "//" or "#" are skipped.
+// By convention the first sample is the signal.
+inline void read_lines(std::string tname, std::vector<std::string>& files) {
+  static const int BUF_SIZE = 512;
+
+  std::ifstream myTxtFile;
+  myTxtFile.open(tname.c_str(), std::ios::in);
+  if (!myTxtFile) {
+    std::cerr << "Input File: " << tname << " could not be opened!" << std::endl;
+    return;
+  }
+
+  char buf[BUF_SIZE];
+  if (myTxtFile) {
+    while (myTxtFile.good()) {
+      if (!myTxtFile.eof()) {
+        myTxtFile.getline(buf, BUF_SIZE, '\n');
+        std::string line(buf);
+        if (line.empty()) continue;
+        if (line.substr(0,2) == "//") continue;
+        if (line.substr(0,1) == "#") continue;
+        files.push_back(line);
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,317 @@
+#ifndef SAMPLELOADER_H
+#define SAMPLELOADER_H
+
+#include <TROOT.h>
+#include <TSystem.h>
+#include <TDirectory.h>
+#include <TFile.h>
+#include <TKey.h>
+#include <TH1.h>
+#include <THnBase.h>
+#include <TString.h>
+
+#include <algorithm>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Opens every sample file once and keeps the handles in an LRU list of at
+// most maxOpenFiles entries. Objects read from a file are detached from it
+// (TH1::SetDirectory(nullptr)) and kept in a second LRU list of at most
+// maxCacheBytes (estimated from the bin arrays), keyed on path, name and
+// the file modification time, so a regenerated file is read again.
+// Callers always get their own copy and own it.
+class SampleLoader {
+public:
+  explicit SampleLoader(size_t maxOpenFiles = 16, size_t maxCacheBytes = 256u << 20)
+    : fMaxOpen(maxOpenFiles), fMaxBytes(maxCacheBytes) {}
+
+  void SetMaxOpenFiles(size_t n) {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fMaxOpen = std::max<size_t>(n, 1);
+    Evict();
+  }
+
+  // 0 disables the object cache; files are still kept open
+  void SetMaxCacheBytes(size_t n) {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fMaxBytes = n;
+    Evict();
+  }
+
+  // Reads names from every path, one pass over the keys of each file, with
+  // up to nThreads files opened and read at the same time (0: all cores).
+  // result[ip][in] is nullptr if the file or the object is missing.
+  std::vector<std::vector<std::unique_ptr<TObject>>>
+  Load(const std::vector<TString>& paths, const std::vector<TString>& names, int nThreads = 0) {
+    std::vector<std::vector<std::unique_ptr<TObject>>> result(paths.size());
+    // A path listed twice is read once; a TFile is never shared between threads
+    std::map<TString, size_t> firstOf;
+    std::vector<size_t> todo;
+    for (size_t ip = 0; ip < paths.size(); ++ip)
+      if (firstOf.emplace(paths[ip], ip).second) todo.push_back(ip);
+
+    size_t nWorkers = nThreads > 0 ? nThreads : std::max(1u, std::thread::hardware_concurrency());
+    nWorkers = std::min(nWorkers, todo.size());
+    if (nWorkers > 1) ROOT::EnableThreadSafety();
+
+    std::mutex nextMutex;
+    size_t next = 0;
+    auto work = [&]() {
+      while (true) {
+        size_t ip;
+        {
+          std::lock_guard<std::mutex> lock(nextMutex);
+          if (next == todo.size()) return;
+          ip = todo[next++];
+        }
+        result[ip] = LoadOne(paths[ip], names);
+      }
+    };
+    if (nWorkers <= 1) {
+      work();
+    }
+    else {
+      std::vector<std::thread> pool;
+      for (size_t iw = 0; iw < nWorkers; ++iw) pool.emplace_back(work);
+      for (auto& t : pool) t.join();
+    }
+    for (size_t ip = 0; ip < paths.size(); ++ip) {
+      const size_t first = firstOf[paths[ip]];
+      if (first == ip) continue;
+      for (auto& obj : result[first]) result[ip].push_back(Detached(obj.get()));
+    }
+    return result;
+  }
+
+  template <class T>
+  std::unique_ptr<T> Get(const TString& path, const TString& name) {
+    auto objs = LoadOne(path, {name});
+    return std::unique_ptr<T>(dynamic_cast<T*>(objs[0].release()));
+  }
+
+  // Closes all files and drops every cached object
+  void Clear() {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fObjects.clear();
+    fObjLru.clear();
+    fBytes = 0;
+    fLru.clear();
+    fFiles.clear();
+  }
+
+private:
+  struct CachedFile {
+    std::unique_ptr<TFile> file;
+    Long_t mtime = 0;
+    std::list<std::string>::iterator lru;
+  };
+  struct CachedObject {
+    std::unique_ptr<TObject> obj;
+    Long_t mtime = 0;
+    size_t bytes = 0;
+    std::list<std::string>::iterator lru;
+  };
+
+  static Long_t ModTime(const TString& path) {
+    FileStat_t st;
+    if (gSystem->GetPathInfo(path, st) != 0) return 0;
+    return st.fMtime;
+  }
+
+  static std::unique_ptr<TObject> Detached(const TObject* obj) {
+    if (!obj) return nullptr;
+    std::unique_ptr<TObject> copy(obj->Clone());
+    if (auto h = dynamic_cast<TH1*>(copy.get())) h->SetDirectory(nullptr);
+    return copy;
+  }
+
+  // Rough in-memory size: the bin arrays dominate for histograms
+  static size_t ObjectBytes(const TObject* obj) {
+    if (auto h = dynamic_cast<const TH1*>(obj))
+      return sizeof(double)*size_t(h->GetNcells())*(h->GetSumw2N() ? 2 : 1) + sizeof(TH1);
+    if (auto hn = dynamic_cast<const THnBase*>(obj))
+      return (sizeof(double) + sizeof(Long64_t))*size_t(hn->GetNbins()) + sizeof(THnBase);
+    return sizeof(TObject);
+  }
+
+  static std::string Key(const TString& path, const TString& name) {
+    return std::string(path.Data()) + "#" + name.Data();
+  }
+
+  std::vector<std::unique_ptr<TObject>> LoadOne(const TString& path, const std::vector<TString>& names) {
+    // TFile::Open would otherwise leave gDirectory pointing at a cached file
+    TDirectory::TContext ctx;
+    std::vector<std::unique_ptr<TObject>> out(names.size());
+    const Long_t mtime = ModTime(path);
+
+    std::vector<size_t> missing;
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      for (size_t in = 0; in < names.size(); ++in) {
+        auto it = fObjects.find(Key(path, names[in]));
+        if (it != fObjects.end() && it->second.mtime == mtime) {
+          fObjLru.splice(fObjLru.begin(), fObjLru, it->second.lru);
+          out[in] = Detached(it->second.obj.get());
+        }
+        else missing.push_back(in);
+      }
+    }
+    if (missing.empty()) return out;
+
+    TFile* file = Acquire(path, mtime);
+    if (!file) return out;
+
+    // Single pass over the top-level keys; names with a path go through Get
+    std::map<TString, size_t> wanted;
+    for (size_t in : missing) wanted[names[in]] = in;
+    std::vector<std::pair<size_t, std::unique_ptr<TObject>>> read;
+    std::set<TString> seen;
+    TIter nextKey(file->GetListOfKeys());
+    while (TKey* key = static_cast<TKey*>(nextKey())) {
+      auto it = wanted.find(key->GetName());
+      if (it == wanted.end() || !seen.insert(key->GetName()).second) continue;  // highest cycle only
+      read.emplace_back(it->second, std::unique_ptr<TObject>(key->ReadObj()));
+    }
+    for (size_t in : missing) {
+      if (seen.count(names[in])) continue;
+      read.emplace_back(in, std::unique_ptr<TObject>(file->Get(names[in])));
+    }
+
+    std::lock_guard<std::mutex> lock(fMutex);
+    for (auto& r : read) {
+      if (!r.second) {
+        std::cerr << names[r.first] << " not found in " << path << std::endl;
+        continue;
+      }
+      if (auto h = dynamic_cast<TH1*>(r.second.get())) h->SetDirectory(nullptr);
+      out[r.first] = Detached(r.second.get());
+      Store(Key(path, names[r.first]), std::move(r.second), mtime);
+    }
+    Release(path);
+    return out;
+  }
+
+  // Returns an open handle for path, pinned until Release(path)
+  TFile* Acquire(const TString& path, Long_t mtime) {
+    const std::string key = path.Data();
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      auto it = fFiles.find(key);
+      if (it != fFiles.end() && it->second.mtime == mtime) {
+        fLru.splice(fLru.begin(), fLru, it->second.lru);
+        ++fPinned[key];
+        return it->second.file.get();
+      }
+    }
+    // Opened outside the lock so several files can be opened at once
+    std::unique_ptr<TFile> file(TFile::Open(path));
+    if (!file || file->IsZombie()) {
+      std::cerr << path << " could not be opened!" << std::endl;
+      return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(fMutex);
+    auto it = fFiles.find(key);
+    if (it != fFiles.end()) {
+      if (fPinned[key] == 0) {
+        fLru.erase(it->second.lru);
+        fFiles.erase(it);
+      }
+      else {
+        // Another thread holds the old handle; use it rather than swapping underneath it
+        ++fPinned[key];
+        return it->second.file.get();
+      }
+    }
+    fLru.push_front(key);
+    TFile* raw = file.get();
+    fFiles[key] = CachedFile{std::move(file), mtime, fLru.begin()};
+    ++fPinned[key];
+    Evict();
+    return raw;
+  }
+
+  // Caller holds fMutex
+  void Store(const std::string& key, std::unique_ptr<TObject> obj, Long_t mtime) {
+    auto it = fObjects.find(key);
+    if (it != fObjects.end()) {
+      fBytes -= it->second.bytes;
+      fObjLru.erase(it->second.lru);
+      fObjects.erase(it);
+    }
+    const size_t bytes = ObjectBytes(obj.get());
+    if (bytes > fMaxBytes) return;  // would evict everything else and itself
+    fObjLru.push_front(key);
+    fObjects[key] = CachedObject{std::move(obj), mtime, bytes, fObjLru.begin()};
+    fBytes += bytes;
+  }
+
+  // Caller holds fMutex
+  void Release(const TString& path) {
+    const std::string key = path.Data();
+    if (--fPinned[key] == 0) fPinned.erase(key);
+    Evict();
+  }
+
+  // Caller holds fMutex; closes the least recently used unpinned files and
+  // drops the least recently used objects beyond the byte budget
+  void Evict() {
+    auto it = fLru.end();
+    while (fFiles.size() > fMaxOpen && it != fLru.begin()) {
+      --it;
+      if (fPinned.count(*it)) continue;
+      fFiles.erase(*it);
+      it = fLru.erase(it);
+    }
+    while (fBytes > fMaxBytes && !fObjLru.empty()) {
+      auto obj = fObjects.find(fObjLru.back());
+      fBytes -= obj->second.bytes;
+      fObjects.erase(obj);
+      fObjLru.pop_back();
+    }
+  }
+
+  size_t fMaxOpen;
+  std::mutex fMutex;
+  std::list<std::string> fLru;
+  std::map<std::string, CachedFile> fFiles;
+  std::map<std::string, int> fPinned;
+  size_t fMaxBytes;
+  size_t fBytes = 0;
+  std::list<std::string> fObjLru;
+  std::map<std::string, CachedObject> fObjects;
+};
+
+// Loader shared by all plotting calls of a session
+inline SampleLoader& sampleLoader() {
+  static SampleLoader loader;
+  return loader;
+}
+
+// One detached histogram per line of a sample list, read from
+// <line><suffix>; entries are nullptr where the file or histogram is missing
+template <class T = TH1D>
+std::vector<std::unique_ptr<T>> loadSampleHists(const std::vector<std::string>& lines, const TString& suffix,
+                                                const TString& histName) {
+  std::vector<TString> paths;
+  for (auto& ln: lines) paths.push_back(TString(ln) + suffix);
+  auto objs = sampleLoader().Load(paths, {histName});
+
+  std::vector<std::unique_ptr<T>> hists;
+  for (size_t ip = 0; ip < paths.size(); ++ip) {
+    std::cout<<paths[ip]<<"\n";
+    T* h = dynamic_cast<T*>(objs[ip][0].get());
+    if (h) objs[ip][0].release();
+    else if (objs[ip][0]) std::cerr << histName << " in " << paths[ip] << " is not a " << T::Class_Name() << std::endl;
+    hists.emplace_back(h);
+  }
+  return hists;
+}
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef SUMMEDAREATABLE_H
+#define SUMMEDAREATABLE_H
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Dense N-dimensional bin contents, last dimension fastest.
+// nBins[d] counts every stored bin of axis d (underflow and overflow included).
+struct DenseGrid {
+  std::vector<int> nBins;
+  std::vector<double> content;
+
+  explicit DenseGrid(std::vector<int> n = {}) : nBins(std::move(n)) {
+    size_t size = 1;
+    for (int nb : nBins) size *= nb;
+    content.assign(nBins.empty() ? 0 : size, 0.0);
+  }
+
+  size_t Index(const std::vector<int>& bin) const {
+    size_t idx = 0;
+    for (size_t d = 0; d < nBins.size(); ++d) idx = idx*nBins[d] + bin[d];
+    return idx;
+  }
+
+  void Add(const DenseGrid& o) {
+    for (size_t i = 0; i < content.size(); ++i) content[i] += o.content[i];
+  }
+};
+
+// Integral image: after one prefix-sum pass per dimension, the sum over any
+// box [lo, hi] (inclusive, per axis) costs 2^N lookups, independent of its size.
+class SummedAreaTable {
+public:
+  explicit SummedAreaTable(const DenseGrid& grid) {
+    const size_t nDim = grid.nBins.size();
+    // One leading zero row per axis so that lo-1 never needs a branch
+    for (int nb : grid.nBins) fDims.push_back(nb + 1);
+    fStride.assign(nDim, 1);
+    for (int d = int(nDim) - 2; d >= 0; --d) fStride[d] = fStride[d+1]*fDims[d+1];
+    fTable.assign(nDim ? fStride[0]*fDims[0] : 0, 0.0);
+
+    std::vector<int> bin(nDim, 0);
+    for (size_t i = 0; i < grid.content.size(); ++i) {
+      size_t idx = 0;
+      for (size_t d = 0; d < nDim; ++d) idx += (bin[d] + 1)*fStride[d];
+      fTable[idx] = grid.content[i];
+      for (int d = int(nDim) - 1; d >= 0 && ++bin[d] == grid.nBins[d]; --d) bin[d] = 0;
+    }
+    for (size_t d = 0; d < nDim; ++d)
+      for (size_t i = 0; i < fTable.size(); ++i)
+        if ((i/fStride[d]) % fDims[d] != 0) fTable[i] += fTable[i - fStride[d]];
+  }
+
+  double Sum(const std::vector<int>& lo, const std::vector<int>& hi) const {
+    const size_t nDim = fDims.size();
+    double sum = 0.0;
+    for (unsigned corner = 0; corner < (1u << nDim); ++corner) {
+      size_t idx = 0;
+      int sign = 1;
+      for (size_t d = 0; d < nDim; ++d) {
+        if (corner & (1u << d)) {
+          idx += lo[d]*fStride[d];  // == (lo-1)+1 in padded coordinates
+          sign = -sign;
+        }
+        else idx += (hi[d] + 1)*fStride[d];
+      }
+      sum += sign*fTable[idx];
+    }
+    return sum;
+  }
+
+private:
+  std::vector<size_t> fDims;
+  std::vector<size_t> fStride;
+  std::vector<double> fTable;
+};
+
+struct CutCandidate {
+  double score = 0.0;
+  double S = 0.0;
+  double B = 0.0;
+  std::vector<int> lo;
+  std::vector<int> hi;
+};
+
+// Scores every combination of the per-axis [lo, hi] choices and returns the
+// nTop best (highest score first). Combinations are split in contiguous
+// slices over nThreads threads, each keeping its own top-N. Candidates with
+// B <= 0 are skipped, as in makeSignificance.
+inline std::vector<CutCandidate>
+searchCuts(const SummedAreaTable& sig, const SummedAreaTable& bkg,
+           const std::vector<std::vector<std::pair<int,int>>>& choices,
+           const std::function<double(double,double)>& metric, size_t nTop, int nThreads) {
+  const size_t nDim = choices.size();
+  size_t nCand = 1;
+  for (auto& c : choices) nCand *= c.size();
+  if (nThreads < 1) nThreads = std::max(1u, std::thread::hardware_concurrency());
+  nThreads = std::max<size_t>(1, std::min<size_t>(nThreads, nCand));
+
+  auto worse = [](const CutCandidate& a, const CutCandidate& b) { return a.score > b.score; };
+  using TopN = std::priority_queue<CutCandidate, std::vector<CutCandidate>, decltype(worse)>;
+  std::vector<TopN> tops(nThreads, TopN(worse));
+
+  auto work = [&](int it) {
+    const size_t first = nCand*it/nThreads, last = nCand*(it+1)/nThreads;
+    // Mixed-radix odometer over the per-axis choices, started at `first`
+    std::vector<size_t> pos(nDim);
+    size_t rest = first;
+    for (int d = int(nDim) - 1; d >= 0; --d) {
+      pos[d] = rest % choices[d].size();
+      rest /= choices[d].size();
+    }
+    std::vector<int> lo(nDim), hi(nDim);
+    for (size_t ic = first; ic < last; ++ic) {
+      for (size_t d = 0; d < nDim; ++d) {
+        lo[d] = choices[d][pos[d]].first;
+        hi[d] = choices[d][pos[d]].second;
+      }
+      const double B = bkg.Sum(lo, hi);
+      if (B > 0) {
+        const double S = sig.Sum(lo, hi);
+        const double score = metric(S, B);
+        TopN& top = tops[it];
+        if (std::isfinite(score) && (top.size() < nTop || (!top.empty() && score > top.top().score))) {
+          top.push({score, S, B, lo, hi});
+          if (top.size() > nTop) top.pop();
+        }
+      }
+      for (int d = int(nDim) - 1; d >= 0 && ++pos[d] == choices[d].size(); --d) pos[d] = 0;
+    }
+  };
+  if (nThreads == 1) {
+    work(0);
+  }
+  else {
+    std::vector<std::thread> pool;
+    for (int it = 0; it < nThreads; ++it) pool.emplace_back(work, it);
+    for (auto& t : pool) t.join();
+  }
+
+  std::vector<CutCandidate> best;
+  for (auto& top : tops)
+    for (; !top.empty(); top.pop()) best.push_back(top.top());
+  std::sort(best.begin(), best.end(), worse);
+  if (best.size() > nTop) best.resize(nTop);
+  return best;
+}
+
+#endif